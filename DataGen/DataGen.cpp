@@ -0,0 +1,165 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DataGen.h"
+
+#include <cctype>
+
+namespace
+{
+    constexpr uint64_t kNumRecentLines{ 1024 };
+}
+
+CDataGenerator::CDataGenerator( const SDataGenSettings &settings ) :
+    fSettings( settings ),
+    fEngine( settings.fSeed )
+{
+    if ( fSettings.fColumns < 4 )
+        fSettings.fColumns = 4;
+    if ( fSettings.fCardinality == 0 )
+        fSettings.fCardinality = 1;
+    fRecentLines.reserve( kNumRecentLines );
+}
+
+// std::uniform_*_distribution differ between standard libraries, mt19937_64 itself does not
+uint64_t CDataGenerator::random( uint64_t max )
+{
+    return fEngine() % max;
+}
+
+double CDataGenerator::randomRate()
+{
+    return static_cast< double >( fEngine() >> 11 ) / static_cast< double >( 1ULL << 53 );
+}
+
+// PSEUDOCELL names like OAOAOAI211111, one per id
+std::string CDataGenerator::cellName( uint64_t cellID ) const
+{
+    static const char *kGates = "AOI";
+    std::string retVal;
+    auto remaining = cellID;
+    do
+    {
+        retVal += kGates[ remaining % 3 ];
+        remaining /= 3;
+    }
+    while ( remaining );
+    retVal += "I" + std::to_string( 2 + ( cellID % 3 ) ) + std::to_string( 11111 + ( cellID % 7 ) );
+    return retVal;
+}
+
+// {>A,0},{>B,1},...,{<H,7:function}
+std::string CDataGenerator::pinList( uint64_t numPins, const std::string &function )
+{
+    std::string pins;
+    for ( auto ii = 0ULL; ii < numPins; ++ii )
+        pins += static_cast< char >( 'A' + ii );
+    for ( auto ii = numPins - 1; ii > 0; --ii )
+        std::swap( pins[ ii ], pins[ random( ii + 1 ) ] );
+
+    std::string retVal;
+    for ( auto ii = 0ULL; ii < numPins; ++ii )
+    {
+        if ( ii )
+            retVal += ",";
+        auto isOutput = ( ii == ( numPins - 1 ) );
+        retVal += std::string( "{" ) + ( isOutput ? "<" : ">" ) + pins[ ii ] + "," + std::to_string( ii );
+        if ( isOutput )
+            retVal += ":" + function;
+        retVal += "}";
+    }
+    return retVal;
+}
+
+std::string CDataGenerator::nextLine()
+{
+    fNumLines++;
+    if ( !fRecentLines.empty() && ( randomRate() < fSettings.fDuplicateRate ) )
+        return fRecentLines[ random( fRecentLines.size() ) ];
+
+    auto cellID = random( fSettings.fCardinality );
+    auto numInputs = 2 + ( cellID % 6 );
+
+    std::string function = ( random( 2 ) == 0 ) ? "I" : "";
+    for ( auto ii = 0ULL; ii < numInputs; ++ii )
+    {
+        auto strength = random( 4 );
+        function += static_cast< char >( 'a' + ii );
+        function += std::to_string( 1 + strength / 2 ) + "." + std::to_string( strength );
+    }
+
+    auto retVal = "alluniquecells.txt:batch" + std::to_string( random( 100 ) ) + "/report_cells.txt:  PSEUDOCELL " + cellName( cellID ) + " " + function;
+    for ( auto ii = 4ULL; ii < fSettings.fColumns; ++ii )
+        retVal += " " + pinList( numInputs + 1, function );
+
+    if ( fRecentLines.size() < kNumRecentLines )
+        fRecentLines.push_back( retVal );
+    else
+        fRecentLines[ fNumLines % kNumRecentLines ] = retVal;
+    return retVal;
+}
+
+uint64_t CDataGenerator::generate( std::ostream &oss )
+{
+    uint64_t numBytes = 0;
+    while ( numBytes < fSettings.fSize )
+    {
+        auto line = nextLine();
+        oss << line << "\n";
+        numBytes += line.length() + 1;
+    }
+    return numBytes;
+}
+
+bool CDataGenerator::parseSize( const std::string &value, uint64_t &size )
+{
+    std::size_t pos = 0;
+    try
+    {
+        size = std::stoull( value, &pos );
+    }
+    catch ( ... )
+    {
+        return false;
+    }
+
+    auto suffix = value.substr( pos );
+    if ( suffix.empty() )
+        return true;
+    if ( suffix.length() != 1 )
+        return false;
+    switch ( std::toupper( suffix[ 0 ] ) )
+    {
+        case 'K':
+            size *= 1024ULL;
+            break;
+        case 'M':
+            size *= 1024ULL * 1024ULL;
+            break;
+        case 'G':
+            size *= 1024ULL * 1024ULL * 1024ULL;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
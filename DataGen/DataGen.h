@@ -0,0 +1,63 @@
+#ifndef __DATAGEN_H
+#define __DATAGEN_H
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <random>
+#include <cstdint>
+
+struct SDataGenSettings
+{
+    uint64_t fSize{ 64 * 1024 * 1024 };   // bytes to generate, stops at the first line boundary past it
+    uint64_t fColumns{ 5 };   // whitespace separated columns per line, the first 4 match report_cells.txt
+    uint64_t fCardinality{ 100000 };   // distinct cell names in column 2
+    double fDuplicateRate{ 0.1 };   // chance a line repeats a recently generated line verbatim
+    uint64_t fSeed{ 42 };
+};
+
+// Reproducible corpus shaped like the report_cells.txt lines, identical for the same settings on every platform
+class CDataGenerator
+{
+public:
+    CDataGenerator( const SDataGenSettings &settings );
+
+    std::string nextLine();
+    uint64_t generate( std::ostream &oss );
+
+    static bool parseSize( const std::string &value, uint64_t &size );
+
+private:
+    uint64_t random( uint64_t max );
+    double randomRate();
+    std::string cellName( uint64_t cellID ) const;
+    std::string pinList( uint64_t numPins, const std::string &function );
+
+    SDataGenSettings fSettings;
+    std::mt19937_64 fEngine;
+    std::vector< std::string > fRecentLines;
+    uint64_t fNumLines{ 0 };
+};
+
+#endif
@@ -0,0 +1,10 @@
+
+set(project_SRCS
+    main.cpp    
+    DataGen.cpp
+)
+
+set(project_H
+    DataGen.h
+)
+
@@ -0,0 +1,100 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DataGen.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void showHelp()
+    {
+        std::cout << "Usage sabgen [--size bytes[K|M|G]] [--columns num] [--cardinality num] [--duplicates rate] [--seed num] [-o outputfile]" << std::endl;
+    }
+}
+
+int main( int argc, char **argv )
+{
+    SDataGenSettings settings;
+    std::string outFile;
+
+    std::vector< std::string > args( argv, argv + argc );
+    for ( auto ii = 1ULL; ii < args.size(); ++ii )
+    {
+        auto currArg = args[ ii ];
+        if ( ii == ( args.size() - 1 ) )
+        {
+            showHelp();
+            return 1;
+        }
+        auto nextArg = args[ ++ii ];
+
+        auto aOK = true;
+        try
+        {
+            if ( currArg == "--size" )
+                aOK = CDataGenerator::parseSize( nextArg, settings.fSize );
+            else if ( currArg == "--columns" )
+                settings.fColumns = std::stoull( nextArg );
+            else if ( currArg == "--cardinality" )
+                settings.fCardinality = std::stoull( nextArg );
+            else if ( currArg == "--duplicates" )
+                settings.fDuplicateRate = std::stod( nextArg );
+            else if ( currArg == "--seed" )
+                settings.fSeed = std::stoull( nextArg );
+            else if ( currArg == "-o" )
+                outFile = nextArg;
+            else
+                aOK = false;
+        }
+        catch ( ... )
+        {
+            aOK = false;
+        }
+
+        if ( !aOK )
+        {
+            std::cerr << "Invalid argument: " << currArg << " " << nextArg << '\n';
+            showHelp();
+            return 1;
+        }
+    }
+
+    auto generator = CDataGenerator( settings );
+    if ( outFile.empty() )
+    {
+        generator.generate( std::cout );
+        return 0;
+    }
+
+    std::ofstream oss( outFile, std::ios::binary );
+    if ( !oss.is_open() )
+    {
+        std::cerr << "Could not open file '" << outFile << "'" << std::endl;
+        return 1;
+    }
+    generator.generate( oss );
+    return 0;
+}
@@ -0,0 +1,463 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Whole program throughput harness for sabsort.
+// Generates a reproducible corpus, runs sabsort over a set of flag combinations both from a file and from stdin,
+// checks each output against an independent reference sort, and compares throughput and peak RSS against a stored baseline.
+
+#include "../DataGen/DataGen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct SScenario
+    {
+        std::string fName;
+        uint64_t fColumn{ -1 * 1ULL };   // -1 sorts on the whole line
+        char fSeparator{ ' ' };
+        bool fUnique{ false };
+        bool fStdin{ false };
+
+        std::vector< std::string > args() const
+        {
+            std::vector< std::string > retVal;
+            if ( fSeparator != ' ' )
+                retVal.push_back( std::string( "-t" ) + fSeparator );
+            if ( fColumn != -1 )
+            {
+                retVal.push_back( "-k" );
+                retVal.push_back( std::to_string( fColumn ) );
+            }
+            if ( fUnique )
+                retVal.push_back( "-u" );
+            return retVal;
+        }
+    };
+
+    // ctest reports the test as skipped, rather than passed, while there is nothing to compare against
+    constexpr int kSkipped{ 77 };
+
+    // written back on every baseline update, keep it in sync with baseline.txt
+    const char *kBaselineHeader = "# sabsort throughput baseline, the median of --runs runs per scenario, refreshed with the UpdateThroughputBaseline target.\n"
+                                  "# It is recorded by whoever cuts a release, on the release machine, and committed with the release.\n"
+                                  "# Until it has entries the Throughput test runs the correctness checks and then reports itself skipped.\n"
+                                  "# The Throughput test fails when a scenario's MB/s drops, or its peak RSS grows, by more than --threshold,\n"
+                                  "# or when a scenario has no entry in a baseline that has others.\n"
+                                  "# Numbers are only comparable within one build type, a baseline from another build type fails the test.\n"
+                                  "# Both are set by THROUGHPUT_ARGS in ThroughputTests/CMakeLists.txt.\n"
+                                  "# On a noisy machine raise --runs or --size before widening --threshold, a larger corpus amortizes process startup.\n"
+                                  "# scenario MB/s peakRSS(KB)\n";
+
+    struct SResult
+    {
+        double fSeconds{ 0.0 };
+        double fMBPerSec{ 0.0 };
+        uint64_t fPeakRSSKB{ 0 };   // 0 when the platform can not report it
+    };
+
+    std::vector< SScenario > getScenarios()
+    {
+        std::vector< SScenario > retVal;
+        for ( auto &&fromStdin : { false, true } )
+        {
+            auto suffix = fromStdin ? "_stdin" : "_file";
+            retVal.push_back( { std::string( "line" ) + suffix, -1 * 1ULL, ' ', false, fromStdin } );
+            retVal.push_back( { std::string( "k2" ) + suffix, 2, ' ', false, fromStdin } );
+            retVal.push_back( { std::string( "k2_u" ) + suffix, 2, ' ', true, fromStdin } );
+            retVal.push_back( { std::string( "t_colon_k1_u" ) + suffix, 1, ':', true, fromStdin } );
+        }
+        return retVal;
+    }
+
+    // runs sabsort with stdout sent to outFile, and stdin read from inFile when it is not empty
+    bool runSabSort( const std::string &sabsort, const std::vector< std::string > &args, const std::string &inFile, const std::string &outFile, SResult &result )
+    {
+        auto start = std::chrono::steady_clock::now();
+#ifdef _WIN32
+        std::string cmd = "\"\"" + sabsort + "\"";
+        for ( auto &&arg : args )
+            cmd += " \"" + arg + "\"";
+        cmd += ( inFile.empty() ? "" : " < \"" + inFile + "\"" ) + " > \"" + outFile + "\"\"";
+        auto aOK = ( std::system( cmd.c_str() ) == 0 );
+#else
+        std::vector< char * > argv;
+        argv.push_back( const_cast< char * >( sabsort.c_str() ) );
+        for ( auto &&arg : args )
+            argv.push_back( const_cast< char * >( arg.c_str() ) );
+        argv.push_back( nullptr );
+
+        auto pid = ::fork();
+        if ( pid == 0 )
+        {
+            if ( !inFile.empty() )
+            {
+                auto inFD = ::open( inFile.c_str(), O_RDONLY );
+                if ( ( inFD < 0 ) || ( ::dup2( inFD, 0 ) < 0 ) )
+                    ::_exit( 127 );
+            }
+            auto outFD = ::open( outFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+            if ( ( outFD < 0 ) || ( ::dup2( outFD, 1 ) < 0 ) )
+                ::_exit( 127 );
+            ::execv( sabsort.c_str(), argv.data() );
+            ::_exit( 127 );
+        }
+        if ( pid < 0 )
+            return false;
+
+        int status = 0;
+        rusage usage{};
+        auto aOK = ( ::wait4( pid, &status, 0, &usage ) == pid ) && WIFEXITED( status ) && ( WEXITSTATUS( status ) == 0 );
+#ifdef __APPLE__
+        result.fPeakRSSKB = usage.ru_maxrss / 1024;
+#else
+        result.fPeakRSSKB = usage.ru_maxrss;
+#endif
+#endif
+        result.fSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+        return aOK;
+    }
+
+    bool getKey( const SScenario &scenario, const std::string &line, std::string &key )
+    {
+        if ( scenario.fColumn == -1 )
+        {
+            key = line;
+            return true;
+        }
+
+        std::vector< std::string > columns;
+        std::istringstream iss( line );
+        for ( std::string column; std::getline( iss, column, scenario.fSeparator ); )
+        {
+            if ( !column.empty() )
+                columns.push_back( column );
+        }
+        if ( columns.empty() )
+            return false;
+        key = columns[ ( scenario.fColumn < columns.size() ) ? scenario.fColumn : 0 ];
+        return true;
+    }
+
+    // deliberately not the map of sets sabsort uses: a stable sort of ( key, line ) pairs followed by a dedupe pass
+    bool referenceSort( const SScenario &scenario, const std::string &corpus, const std::string &expectedFile )
+    {
+        std::vector< std::pair< std::string, std::string > > keyed;
+        std::ifstream iss( corpus, std::ios::binary );
+        std::string key;
+        for ( std::string line; std::getline( iss, line ); )
+        {
+            if ( getKey( scenario, line, key ) )
+                keyed.emplace_back( key, std::move( line ) );
+        }
+
+        auto keyedUnique = scenario.fUnique && ( scenario.fColumn != -1 );
+        if ( keyedUnique )
+            std::stable_sort( keyed.begin(), keyed.end(), []( auto &&lhs, auto &&rhs ) { return lhs.first < rhs.first; } );
+        else
+            std::sort( keyed.begin(), keyed.end() );
+
+        std::ofstream oss( expectedFile, std::ios::binary );
+        for ( auto ii = 0ULL; ii < keyed.size(); ++ii )
+        {
+            if ( ii && ( keyed[ ii ].first == keyed[ ii - 1 ].first ) && ( keyedUnique || ( keyed[ ii ].second == keyed[ ii - 1 ].second ) ) )
+                continue;
+            oss << keyed[ ii ].second << "\n";
+        }
+        return static_cast< bool >( oss.flush() );
+    }
+
+    // a forked sabsort starts with the harness's pages counted in its peak RSS, so the reference sort runs in a process of its own
+    bool writeReferenceSort( const SScenario &scenario, const std::string &corpus, const std::string &expectedFile )
+    {
+#ifdef _WIN32
+        return referenceSort( scenario, corpus, expectedFile );
+#else
+        auto pid = ::fork();
+        if ( pid == 0 )
+            ::_exit( referenceSort( scenario, corpus, expectedFile ) ? 0 : 1 );
+        if ( pid < 0 )
+            return false;
+
+        int status = 0;
+        return ( ::waitpid( pid, &status, 0 ) == pid ) && WIFEXITED( status ) && ( WEXITSTATUS( status ) == 0 );
+#endif
+    }
+
+    bool checkOutput( const std::string &expectedFile, const std::string &outFile )
+    {
+        std::ifstream expected( expectedFile, std::ios::binary );
+        std::ifstream actual( outFile, std::ios::binary );
+        std::string expectedLine;
+        std::string actualLine;
+        for ( auto lineNum = 1ULL;; ++lineNum )
+        {
+            auto haveExpected = static_cast< bool >( std::getline( expected, expectedLine ) );
+            auto haveActual = static_cast< bool >( std::getline( actual, actualLine ) );
+            if ( !haveExpected && !haveActual )
+                return true;
+            if ( haveExpected != haveActual )
+            {
+                std::cerr << "    Output " << ( haveActual ? "has more" : "has fewer" ) << " lines than the reference sort, from line " << lineNum << '\n';
+                return false;
+            }
+            if ( expectedLine != actualLine )
+            {
+                std::cerr << "    Output differs from the reference sort at line " << lineNum << '\n';
+                return false;
+            }
+        }
+    }
+
+    struct SBaseline
+    {
+        std::string fBuildType;   // the build type of the sabsort that recorded it
+        std::map< std::string, SResult > fResults;
+    };
+
+    SBaseline loadBaseline( const std::string &fileName )
+    {
+        SBaseline retVal;
+        std::ifstream iss( fileName );
+        for ( std::string line; std::getline( iss, line ); )
+        {
+            if ( line.empty() || ( line[ 0 ] == '#' ) )
+                continue;
+            std::istringstream lineStream( line );
+            std::string name;
+            lineStream >> name;
+            if ( name == "build-type" )
+            {
+                lineStream >> retVal.fBuildType;
+                continue;
+            }
+            SResult result;
+            if ( lineStream >> result.fMBPerSec >> result.fPeakRSSKB )
+                retVal.fResults[ name ] = result;
+        }
+        return retVal;
+    }
+
+    bool saveBaseline( const std::string &fileName, const std::string &buildType, const std::map< std::string, SResult > &results )
+    {
+        std::ofstream oss( fileName );
+        if ( !oss.is_open() )
+            return false;
+        oss << kBaselineHeader;
+        oss << "build-type " << buildType << "\n";
+        for ( auto &&[ name, result ] : results )
+            oss << name << " " << std::fixed << std::setprecision( 2 ) << result.fMBPerSec << " " << result.fPeakRSSKB << "\n";
+        return true;
+    }
+
+    void showHelp()
+    {
+        std::cout << "Usage ThroughputTests --sabsort exe [--baseline file] [--work dir] [--size bytes[K|M|G]] [--runs num] [--threshold fraction] [--build-type name] [--update-baseline]" << std::endl;
+    }
+}
+
+int main( int argc, char **argv )
+{
+    std::string sabsort;
+    std::string baselineFile;
+    std::string buildType = "None";
+    std::string workDir = std::filesystem::temp_directory_path().string();
+    uint64_t numRuns = 5;
+    double threshold = 0.35;
+    bool updateBaseline = false;
+    SDataGenSettings genSettings;
+
+    std::vector< std::string > args( argv, argv + argc );
+    for ( auto ii = 1ULL; ii < args.size(); ++ii )
+    {
+        auto currArg = args[ ii ];
+        if ( currArg == "--update-baseline" )
+        {
+            updateBaseline = true;
+            continue;
+        }
+        if ( ii == ( args.size() - 1 ) )
+        {
+            showHelp();
+            return 1;
+        }
+        auto nextArg = args[ ++ii ];
+
+        auto aOK = true;
+        try
+        {
+            if ( currArg == "--sabsort" )
+                sabsort = nextArg;
+            else if ( currArg == "--baseline" )
+                baselineFile = nextArg;
+            else if ( currArg == "--build-type" )
+                buildType = nextArg;
+            else if ( currArg == "--work" )
+                workDir = nextArg;
+            else if ( currArg == "--size" )
+                aOK = CDataGenerator::parseSize( nextArg, genSettings.fSize );
+            else if ( currArg == "--runs" )
+                numRuns = std::max( 1ULL, static_cast< unsigned long long >( std::stoull( nextArg ) ) );
+            else if ( currArg == "--threshold" )
+                threshold = std::stod( nextArg );
+            else
+                aOK = false;
+        }
+        catch ( ... )
+        {
+            aOK = false;
+        }
+        if ( !aOK )
+        {
+            std::cerr << "Invalid argument: " << currArg << " " << nextArg << '\n';
+            showHelp();
+            return 1;
+        }
+    }
+    if ( sabsort.empty() || ( updateBaseline && baselineFile.empty() ) )
+    {
+        showHelp();
+        return 1;
+    }
+
+    auto baseline = loadBaseline( baselineFile );
+    if ( !updateBaseline && !baseline.fResults.empty() && ( baseline.fBuildType != buildType ) )
+    {
+        std::cerr << "Baseline '" << baselineFile << "' was recorded from a " << ( baseline.fBuildType.empty() ? std::string( "unknown" ) : baseline.fBuildType ) << " build, this is a " << buildType << " build" << std::endl;
+        return 1;
+    }
+
+    auto corpus = ( std::filesystem::path( workDir ) / "throughput_corpus.txt" ).string();
+    auto outFile = ( std::filesystem::path( workDir ) / "throughput_output.txt" ).string();
+    auto expectedFile = ( std::filesystem::path( workDir ) / "throughput_expected.txt" ).string();
+    {
+        std::ofstream oss( corpus, std::ios::binary );
+        if ( !oss.is_open() )
+        {
+            std::cerr << "Could not open file '" << corpus << "'" << std::endl;
+            return 1;
+        }
+        CDataGenerator( genSettings ).generate( oss );
+    }
+    auto corpusMB = static_cast< double >( std::filesystem::file_size( corpus ) ) / ( 1024.0 * 1024.0 );
+    std::cout << "Corpus: " << corpus << " (" << std::fixed << std::setprecision( 2 ) << corpusMB << " MB)\n";
+
+    std::map< std::string, SResult > results;
+    auto aOK = true;
+    for ( auto &&scenario : getScenarios() )
+    {
+        std::cout << scenario.fName << ":";
+        if ( !writeReferenceSort( scenario, corpus, expectedFile ) )
+        {
+            std::cout << " FAILED to write the reference sort\n";
+            aOK = false;
+            continue;
+        }
+
+        auto args = scenario.args();
+        if ( !scenario.fStdin )
+            args.push_back( corpus );
+
+        std::vector< SResult > runs;
+        auto ran = true;
+        for ( auto run = 0ULL; ran && ( run < numRuns ); ++run )
+        {
+            SResult curr;
+            ran = runSabSort( sabsort, args, scenario.fStdin ? corpus : std::string(), outFile, curr ) && checkOutput( expectedFile, outFile );
+            curr.fMBPerSec = corpusMB / curr.fSeconds;
+            runs.push_back( curr );
+        }
+        if ( !ran )
+        {
+            std::cout << " FAILED\n";
+            aOK = false;
+            continue;
+        }
+
+        // the median run, one outlier in either direction does not move it
+        std::sort( runs.begin(), runs.end(), []( auto &&lhs, auto &&rhs ) { return lhs.fMBPerSec < rhs.fMBPerSec; } );
+        auto median = runs[ runs.size() / 2 ];
+        results[ scenario.fName ] = median;
+        std::cout << " " << median.fMBPerSec << " MB/s, peak RSS " << median.fPeakRSSKB << " KB";
+
+        if ( updateBaseline || baseline.fResults.empty() )
+        {
+            std::cout << "\n";
+            continue;
+        }
+        auto pos = baseline.fResults.find( scenario.fName );
+        if ( pos == baseline.fResults.end() )
+        {
+            std::cout << " MISSING from the baseline\n";
+            aOK = false;
+            continue;
+        }
+
+        auto slower = median.fMBPerSec < ( pos->second.fMBPerSec * ( 1.0 - threshold ) );
+        auto larger = ( median.fPeakRSSKB != 0 ) && ( pos->second.fPeakRSSKB != 0 ) && ( median.fPeakRSSKB > ( pos->second.fPeakRSSKB * ( 1.0 + threshold ) ) );
+        std::cout << " (baseline " << pos->second.fMBPerSec << " MB/s, " << pos->second.fPeakRSSKB << " KB)";
+        if ( slower || larger )
+        {
+            std::cout << " REGRESSED";
+            aOK = false;
+        }
+        std::cout << "\n";
+    }
+
+    std::filesystem::remove( outFile );
+    std::filesystem::remove( expectedFile );
+    std::filesystem::remove( corpus );
+
+    if ( updateBaseline )
+    {
+        if ( !aOK || !saveBaseline( baselineFile, buildType, results ) )
+        {
+            std::cerr << "Could not update baseline '" << baselineFile << "'" << std::endl;
+            return 1;
+        }
+        std::cout << "Updated baseline '" << baselineFile << "'\n";
+        return 0;
+    }
+    if ( aOK && baseline.fResults.empty() )
+    {
+        std::cout << "No baseline in '" << baselineFile << "', skipping the throughput comparison. Record one with the UpdateThroughputBaseline target.\n";
+        return kSkipped;
+    }
+    return aOK ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+
+set(project_SRCS
+    ThroughputTests.cpp
+    ../DataGen/DataGen.cpp
+)
+
+set(project_H
+    ../DataGen/DataGen.h
+)
+
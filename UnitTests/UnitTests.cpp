@@ -2,9 +2,111 @@
 
 #include "../main/Utils.h"
 #include "../main/Settings.h"
+#include "../main/HyperLogLog.h"
+#include "../main/Server.h"
+#include "../DataGen/DataGen.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
+    struct SRunResult
+    {
+        int fExitCode{ 0 };
+        std::string fOut;
+        std::string fErr;
+    };
+
+    void writeFile( const std::string &fileName, const std::string &contents )
+    {
+        std::ofstream oss( fileName, std::ios::binary );
+        oss << contents;
+    }
+
+    // runs the settings as main() would, with the output captured and stdin read from input
+    // setup, when given, adjusts the parsed settings before they run
+    SRunResult runCaptured( const std::vector< std::string > &args, const std::string &input = {}, const std::function< void( CSettings & ) > &setup = {} )
+    {
+        std::ostringstream out;
+        std::ostringstream err;
+        std::istringstream in( input );
+
+        SRunResult retVal;
+        auto settings = CSettings( args, out, err, in, {} );
+        if ( setup )
+            setup( settings );
+        retVal.fExitCode = settings.run();
+        retVal.fOut = out.str();
+        retVal.fErr = err.str();
+        return retVal;
+    }
+
+#ifndef _WIN32
+    std::string getSocketPath()
+    {
+        return ( std::filesystem::temp_directory_path() / ( "sabsort_test_" + std::to_string( std::chrono::steady_clock::now().time_since_epoch().count() ) + ".sock" ) ).string();
+    }
+
+    // serves maxJobs connections on its own thread, false when the socket could not be set up
+    bool startServer( const std::string &socketPath, uint64_t maxJobs, std::thread &server )
+    {
+        std::promise< bool > listening;
+        server = std::thread(
+            [ &listening, socketPath, maxJobs ]()
+            {
+                auto started = false;
+                runServer( socketPath, maxJobs,
+                           [ & ]()
+                           {
+                               started = true;
+                               listening.set_value( true );
+                           } );
+                if ( !started )
+                    listening.set_value( false );
+            } );
+        if ( listening.get_future().get() )
+            return true;
+        server.join();
+        return false;
+    }
+
+    // runs the client as main() would, with the std streams captured and stdin read from input
+    SRunResult runClientCaptured( const std::string &socketPath, const std::vector< std::string > &args, const std::string &input, bool sendStdin )
+    {
+        std::ostringstream out;
+        std::ostringstream err;
+        std::istringstream in( input );
+        auto origOut = std::cout.rdbuf( out.rdbuf() );
+        auto origErr = std::cerr.rdbuf( err.rdbuf() );
+        auto origIn = std::cin.rdbuf( in.rdbuf() );
+
+        SRunResult retVal;
+        retVal.fExitCode = runClient( socketPath, args, sendStdin );
+
+        std::cout.rdbuf( origOut );
+        std::cerr.rdbuf( origErr );
+        std::cin.rdbuf( origIn );
+        std::cin.clear();
+        retVal.fOut = out.str();
+        retVal.fErr = err.str();
+        return retVal;
+    }
+#endif
+
     TEST( TestUtils, EscapeCode )
     {
         EXPECT_EQ( 0x07, getEscapedChar( "\\a" ) );
@@ -32,12 +134,12 @@ namespace
     TEST( TestUtils, GetSeparator )
     {
         {
-            auto ii = 0ULL;
+            std::size_t ii = 0;
             EXPECT_EQ( ' ', getSeparator( ii, { "-t", "'", "'" } ) );
             EXPECT_EQ( 2, ii );
         }
         {
-            auto ii = 0ULL;
+            std::size_t ii = 0;
             EXPECT_EQ( ' ', getSeparator( ii, { "-t'", "'" } ) );
             EXPECT_EQ( 1, ii );
         }
@@ -60,7 +162,7 @@ namespace
         for ( auto && [ key, answer ] : chars )
         {
             std::string keyString = std::string( 1, key );
-            auto ii = 0ULL;
+            std::size_t ii = 0;
             EXPECT_EQ( answer, getSeparator( ii, { "-t" + keyString } ) );
             EXPECT_EQ( 0, ii );
 
@@ -88,17 +190,421 @@ namespace
         EXPECT_EQ( ' ', settings.separator() );
     }
 
-    TEST( TestSort, Batch10 )
+    TEST( TestHyperLogLog, Estimate )
+    {
+        CHyperLogLog hll;
+        EXPECT_EQ( 0, static_cast< uint64_t >( hll.estimate() ) );
+
+        for ( auto ii = 0; ii < 1000; ++ii )
+            hll.add( "key" + std::to_string( ii % 100 ) );
+        EXPECT_EQ( 1000, hll.numAdded() );
+        EXPECT_NEAR( 100.0, hll.estimate(), 5.0 );
+
+        CHyperLogLog large;
+        for ( auto ii = 0; ii < 200000; ++ii )
+            large.add( std::to_string( ii ) );
+        EXPECT_NEAR( 200000.0, large.estimate(), 200000.0 * 0.03 );
+    }
+
+    TEST( TestSettings, ExtrapolateKeys )
+    {
+        // nothing to project
+        EXPECT_EQ( 500, CSettings::extrapolateKeys( 500, 1000, 1000 ) );
+        EXPECT_EQ( 500, CSettings::extrapolateKeys( 500, 0, 1000 ) );
+        // no repeats in the sample, every line is a new key
+        EXPECT_EQ( 100000, CSettings::extrapolateKeys( 1000, 1000, 100000 ) );
+        // a saturated sample stays put
+        EXPECT_EQ( 500, CSettings::extrapolateKeys( 500, 100000, 10000000 ) );
+
+        // 30000 uniform draws from 100000 keys see about 25918 of them, 300000 draws see about 95021
+        auto estimate = CSettings::extrapolateKeys( 25918, 30000, 300000 );
+        EXPECT_NEAR( 95021.0, static_cast< double >( estimate ), 500.0 );
+    }
+
+    TEST( TestSettings, PlansMatch )
     {
-        auto input = "alluniquecells.txt:batch10/report_cells.txt:  PSEUDOCELL OAOAOAI211111 Ia2.0b2.0c2.0d2.0e2.0f2.0 {>A,0},{>B,1},{>C,2},{>D,3},{>E,4},{>F,5},{>G,6},{<H,7:Ia2.0b2.0c2.0d2.0e2.0f2.0}\n"
-                     "alluniquecells.txt:batch10/report_cells.txt:  PSEUDOCELL AOAOAOI211111 a2.1b2.1c2.1d2.1e2.1f2.2 {>E,0},{>H,1},{>D,2},{>A,3},{>F,4},{>B,5},{>C,6},{<G,7:a2.1b2.1c2.1d2.1e2.1f2.2}\n";
+        SDataGenSettings genSettings;
+        genSettings.fSize = 2 * 1024 * 1024;
+        genSettings.fCardinality = 5000;
+        std::ostringstream corpus;
+        CDataGenerator( genSettings ).generate( corpus );
 
-        auto args = std::vector< std::string >( { "appName.exe" } );
+        auto fileName = std::string( "TestPlansMatch.txt" );
+        writeFile( fileName, corpus.str() );
+
+        auto argSets = std::vector< std::vector< std::string > >( {
+            { "appName.exe" },
+            { "appName.exe", "-u" },
+            { "appName.exe", "-k", "2" },
+            { "appName.exe", "-k", "2", "-u" },
+            { "appName.exe", "-t", ":", "-k", "1", "-u" },
+        } );
+        auto orderedMap = []( CSettings &settings ) { settings.setPlan( EExecutionPlan::eOrderedMap ); };
+        auto hashTable = []( CSettings &settings ) { settings.setPlan( EExecutionPlan::eHashTable ); };
+        for ( auto &&args : argSets )
+        {
+            auto withFile = args;
+            withFile.push_back( fileName );
+
+            auto ordered = runCaptured( withFile, {}, orderedMap );
+            auto hashed = runCaptured( withFile, {}, hashTable );
+            EXPECT_EQ( 0, ordered.fExitCode );
+            EXPECT_FALSE( ordered.fOut.empty() );
+            EXPECT_EQ( ordered.fOut, hashed.fOut );
+            EXPECT_EQ( ordered.fOut, runCaptured( withFile ).fOut );
+            EXPECT_EQ( ordered.fOut, runCaptured( args, corpus.str(), hashTable ).fOut );
+            EXPECT_EQ( ordered.fOut, runCaptured( args, corpus.str(), orderedMap ).fOut );
+        }
+        std::remove( fileName.c_str() );
+    }
+
+    TEST( TestSettings, PlanDecision )
+    {
+        struct SCase
+        {
+            uint64_t fSize;
+            uint64_t fCardinality;
+            std::string fPlan;
+        };
+        auto cases = std::vector< SCase >( {
+            // past kSampleBytes, the few keys in the sample have to extrapolate to few keys overall
+            { 6 * 1024 * 1024, 50, "Plan: ordered map\n" },
+            { 1024 * 1024, 1000000, "Plan: hash table\n" },
+        } );
+
+        auto fileName = std::string( "TestPlanDecision.txt" );
+        for ( auto &&[ size, cardinality, plan ] : cases )
+        {
+            SDataGenSettings genSettings;
+            genSettings.fSize = size;
+            genSettings.fCardinality = cardinality;
+            std::ostringstream corpus;
+            CDataGenerator( genSettings ).generate( corpus );
+            writeFile( fileName, corpus.str() );
+
+            auto withPlan = runCaptured( { "appName.exe", "--plan", "-k", "2", fileName } );
+            auto withoutPlan = runCaptured( { "appName.exe", "-k", "2", fileName } );
+            EXPECT_EQ( 0, withPlan.fExitCode ) << cardinality;
+            EXPECT_EQ( plan, withPlan.fErr.substr( 0, withPlan.fErr.find( '\n' ) + 1 ) ) << cardinality;
+            EXPECT_EQ( "", withoutPlan.fErr ) << cardinality;
+            EXPECT_FALSE( withPlan.fOut.empty() ) << cardinality;
+            EXPECT_EQ( withoutPlan.fOut, withPlan.fOut ) << cardinality;
+        }
+        std::remove( fileName.c_str() );
+    }
+
+    TEST( TestSettings, GetPlanSettings )
+    {
+        auto args = std::vector< std::string >( { "appName.exe", "--plan", "-k", "2" } );
         auto settings = CSettings( args );
-        settings
-        
+        EXPECT_TRUE( settings.aOK() );
+        EXPECT_TRUE( settings.showPlan() );
+        EXPECT_EQ( 0, settings.numFiles() );
+        EXPECT_EQ( 2, settings.sortColumn() );
     }
 
+    TEST( TestSettings, GetServerSettings )
+    {
+        {
+            auto args = std::vector< std::string >( { "appName.exe", "--serve", "/tmp/sabsort.sock" } );
+            auto settings = CSettings( args );
+            EXPECT_TRUE( settings.aOK() );
+            EXPECT_TRUE( settings.serve() );
+            EXPECT_FALSE( settings.connect() );
+            EXPECT_EQ( "/tmp/sabsort.sock", settings.socketPath() );
+        }
+        {
+            auto args = std::vector< std::string >( { "appName.exe", "-u", "--connect", "/tmp/sabsort.sock", "-k", "2" } );
+            auto settings = CSettings( args );
+            EXPECT_TRUE( settings.aOK() );
+            EXPECT_FALSE( settings.serve() );
+            EXPECT_TRUE( settings.connect() );
+            EXPECT_EQ( "/tmp/sabsort.sock", settings.socketPath() );
+            EXPECT_EQ( std::vector< std::string >( { "appName.exe", "-u", "-k", "2" } ), settings.forwardArgs() );
+        }
+        {
+            auto args = std::vector< std::string >( { "appName.exe", "--connect", "a.sock", "--serve", "b.sock" } );
+            auto settings = CSettings( args );
+            EXPECT_FALSE( settings.aOK() );
+        }
+    }
+
+    TEST( TestServer, MatchesStandalone )
+    {
+#ifdef _WIN32
+        GTEST_SKIP() << "--serve is not supported on this platform";
+#else
+        auto fileName = std::string( "TestServer.txt" );
+        writeFile( fileName, "b 2\na 1\nc 3\na 0\nb 2\n" );
+        auto input = std::string( "z\ny\nz\nx" );
+        auto socketPath = getSocketPath();
+
+        struct SJob
+        {
+            std::vector< std::string > fArgs;
+            std::string fInput;
+            bool fSendStdin;   // what main() passes, numFiles() == 0
+        };
+        auto jobs = std::vector< SJob >( {
+            { { "appName.exe", "-k", "1", fileName }, "", false },
+            { { "appName.exe", "-u" }, input, true },
+            { { "appName.exe", "NoSuchFile.txt" }, "", false },
+        } );
+
+        std::thread server;
+        ASSERT_TRUE( startServer( socketPath, jobs.size(), server ) ) << "Could not start the server on " << socketPath;
+
+        for ( auto &&[ args, currInput, sendStdin ] : jobs )
+        {
+            auto standalone = runCaptured( args, currInput );
+            auto served = runClientCaptured( socketPath, args, currInput, sendStdin );
+            EXPECT_EQ( standalone.fExitCode, served.fExitCode );
+            EXPECT_EQ( standalone.fOut, served.fOut );
+            EXPECT_EQ( standalone.fErr, served.fErr );
+        }
+        server.join();
+
+        EXPECT_EQ( "a 0\na 1\nb 2\nc 3\n", runCaptured( jobs[ 0 ].fArgs ).fOut );
+        EXPECT_EQ( 1, runCaptured( jobs[ 2 ].fArgs ).fExitCode );
+        std::remove( fileName.c_str() );
+#endif
+    }
+
+    TEST( TestServer, StalledClient )
+    {
+#ifdef _WIN32
+        GTEST_SKIP() << "--serve is not supported on this platform";
+#else
+        auto socketPath = getSocketPath();
+        std::thread server;
+        ASSERT_TRUE( startServer( socketPath, 2, server ) ) << "Could not start the server on " << socketPath;
+
+        // connects first and never sends its request
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy( addr.sun_path, socketPath.c_str(), sizeof( addr.sun_path ) - 1 );
+        auto stalledFD = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+        ASSERT_GE( stalledFD, 0 );
+        EXPECT_EQ( 0, ::connect( stalledFD, reinterpret_cast< sockaddr * >( &addr ), sizeof( addr ) ) );
+
+        // far below the server's request deadline, the job must not wait behind the stalled connection
+        auto start = std::chrono::steady_clock::now();
+        auto served = runClientCaptured( socketPath, { "appName.exe" }, "b\na\n", true );
+        EXPECT_LT( std::chrono::steady_clock::now() - start, std::chrono::seconds( 5 ) );
+        EXPECT_EQ( 0, served.fExitCode );
+        EXPECT_EQ( "a\nb\n", served.fOut );
+        EXPECT_EQ( "", served.fErr );
+
+        ::close( stalledFD );
+        server.join();
+#endif
+    }
+
+    TEST( TestServer, DroppedConnection )
+    {
+#ifdef _WIN32
+        GTEST_SKIP() << "--serve is not supported on this platform";
+#else
+        auto socketPath = getSocketPath();
+        std::thread server;
+        ASSERT_TRUE( startServer( socketPath, 1, server ) ) << "Could not start the server on " << socketPath;
+
+        // more arguments than the server accepts, it hangs up while the client is still writing megabytes of them
+        auto args = std::vector< std::string >( 5000, std::string( 1024, 'a' ) );
+        args.front() = "appName.exe";
+        auto served = runClientCaptured( socketPath, args, {}, false );
+        EXPECT_EQ( 1, served.fExitCode );
+        EXPECT_EQ( "Lost connection to '" + socketPath + "'\n", served.fErr );
+        EXPECT_EQ( "", served.fOut );
+        server.join();
+#endif
+    }
+
+    TEST( TestDataGen, Reproducible )
+    {
+        uint64_t size = 0;
+        EXPECT_TRUE( CDataGenerator::parseSize( "64", size ) );
+        EXPECT_EQ( 64, size );
+        EXPECT_TRUE( CDataGenerator::parseSize( "2M", size ) );
+        EXPECT_EQ( 2 * 1024 * 1024, size );
+        EXPECT_TRUE( CDataGenerator::parseSize( "1g", size ) );
+        EXPECT_EQ( 1024ULL * 1024 * 1024, size );
+        EXPECT_FALSE( CDataGenerator::parseSize( "1MB", size ) );
+        EXPECT_FALSE( CDataGenerator::parseSize( "M", size ) );
+
+        SDataGenSettings settings;
+        settings.fSize = 64 * 1024;
+        settings.fColumns = 6;
+        std::ostringstream first;
+        std::ostringstream second;
+        EXPECT_EQ( CDataGenerator( settings ).generate( first ), CDataGenerator( settings ).generate( second ) );
+        EXPECT_EQ( first.str(), second.str() );
+        EXPECT_GE( first.str().length(), settings.fSize );
+
+        std::istringstream iss( first.str() );
+        for ( std::string line; std::getline( iss, line ); )
+        {
+            auto split = splitLine( line, false, ' ' );
+            ASSERT_EQ( 6, split.size() );
+            EXPECT_EQ( "PSEUDOCELL", split[ 1 ] );
+        }
+
+        settings.fSeed++;
+        std::ostringstream third;
+        CDataGenerator( settings ).generate( third );
+        EXPECT_NE( first.str(), third.str() );
+    }
+
+    TEST( TestSettings, CheckOrder )
+    {
+        auto fileName = std::string( "TestCheckOrder.txt" );
+        struct SCase
+        {
+            std::string fContents;
+            std::vector< std::string > fArgs;
+            std::string fError;   // empty when in order
+        };
+        auto cases = std::vector< SCase >( {
+            { "", {}, "" },
+            { "a\nb\nc\n", {}, "" },
+            { "a\nb\nc", {}, "" },
+            { "a\nc\nb\n", {}, fileName + ":3: disorder: b\n" },
+            { "a\nb\nb\n", {}, "" },
+            { "a\nb\nb\n", { "-u" }, fileName + ":3: duplicate: b\n" },
+
+            { "z a\ny b\nx c\n", { "-k", "1" }, "" },
+            { "z b\ny a\n", { "-k", "1" }, fileName + ":2: disorder: y a\n" },
+            { "x a\ny a\n", { "-k", "1" }, "" },
+            { "y a\nx a\n", { "-k", "1" }, fileName + ":2: disorder: x a\n" },
+            { "x a\ny a\n", { "-k", "1", "-u" }, fileName + ":2: duplicate: y a\n" },
+            { "b:1\na:2\n", { "-t", ":", "-k", "1", "-u" }, "" },
+        } );
+
+        for ( auto &&[ contents, args, error ] : cases )
+        {
+            writeFile( fileName, contents );
+            auto currArgs = std::vector< std::string >( { "appName.exe", "-c" } );
+            currArgs.insert( currArgs.end(), args.begin(), args.end() );
+            currArgs.push_back( fileName );
+
+            auto result = runCaptured( currArgs, {}, []( CSettings &settings ) { EXPECT_TRUE( settings.checkOnly() ); } );
+            EXPECT_EQ( error.empty() ? 0 : 1, result.fExitCode ) << contents;
+            EXPECT_EQ( error, result.fErr ) << contents;
+            EXPECT_EQ( "", result.fOut ) << contents;
+        }
+
+        std::remove( fileName.c_str() );
+    }
+
+    TEST( TestSettings, CheckChunkBoundaries )
+    {
+        auto fileName = std::string( "TestCheckChunks.txt" );
+        struct SCase
+        {
+            std::string fContents;
+            std::vector< std::string > fArgs;
+            std::string fError;   // empty when in order
+        };
+        auto cases = std::vector< SCase >( {
+            // every line starts on a chunk boundary for 2, 4 and 8 chunks
+            { "a\nb\nd\nc\n", {}, fileName + ":4: disorder: c\n" },
+            // lines straddle the boundaries for most chunk counts
+            { "aa\nbb\ncc\nab\n", {}, fileName + ":4: disorder: ab\n" },
+            { "aa\nbb\ncc\ndd\n", {}, "" },
+            { "a\nb\nb\n", { "-u" }, fileName + ":3: duplicate: b\n" },
+            // the line count of the earlier chunks has to add up
+            { "a\nb\nc\nd\ne\nf\ng\nh\ni\nj\nb\nk\n", {}, fileName + ":11: disorder: b\n" },
+            { "z a\ny b\n\nx c\nw b\n", { "-k", "1" }, fileName + ":5: disorder: w b\n" },
+            { "z a\ny b\n\nx c\nw d", { "-k", "1" }, "" },
+        } );
+
+        for ( auto &&[ contents, args, error ] : cases )
+        {
+            writeFile( fileName, contents );
+            auto currArgs = std::vector< std::string >( { "appName.exe", "-c" } );
+            currArgs.insert( currArgs.end(), args.begin(), args.end() );
+            currArgs.push_back( fileName );
+
+            for ( auto numChunks = 1ULL; numChunks <= ( contents.length() + 1 ); ++numChunks )
+            {
+                auto result = runCaptured( currArgs, {}, [ numChunks ]( CSettings &settings ) { settings.setCheckChunks( numChunks ); } );
+                EXPECT_EQ( error.empty() ? 0 : 1, result.fExitCode ) << contents << " in " << numChunks << " chunks";
+                EXPECT_EQ( error, result.fErr ) << contents << " in " << numChunks << " chunks";
+                EXPECT_EQ( "", result.fOut );
+            }
+        }
+
+#ifndef _WIN32
+        // a file that goes away after the arguments are parsed must fail the check, not pass it
+        writeFile( fileName, "a\nb\n" );
+        auto result = runCaptured( { "appName.exe", "-c", fileName }, {}, [ & ]( CSettings & ) { std::remove( fileName.c_str() ); } );
+        EXPECT_EQ( 1, result.fExitCode );
+        EXPECT_EQ( "Could not open file '" + fileName + "'\n", result.fErr );
+#endif
+        std::remove( fileName.c_str() );
+    }
+
+    TEST( TestSettings, CheckCRLF )
+    {
+        // "x" sorts before "x\ty", but "x\r" sorts after "x\ty\r"
+        auto fileName = std::string( "TestCheckCRLF.txt" );
+        writeFile( fileName, "x\r\nx\ty\r\nw\r\n" );
+        auto sorted = runCaptured( { "appName.exe", fileName } );
+        EXPECT_EQ( 0, sorted.fExitCode );
+        auto unsorted = runCaptured( { "appName.exe", "-c", fileName } );
+#ifdef _WIN32
+        // text mode drops the '\r' reading the input, and adds it back when stdout is a file
+        EXPECT_EQ( "w\nx\nx\ty\n", sorted.fOut );
+        EXPECT_EQ( fileName + ":3: disorder: w\n", unsorted.fErr );
+        std::string onDisk;
+        for ( auto &&ch : sorted.fOut )
+        {
+            if ( ch == '\n' )
+                onDisk += '\r';
+            onDisk += ch;
+        }
+#else
+        EXPECT_EQ( "w\r\nx\ty\r\nx\r\n", sorted.fOut );
+        EXPECT_EQ( fileName + ":2: disorder: x\ty\r\n", unsorted.fErr );
+        auto onDisk = sorted.fOut;
+#endif
+
+        // what sabsort wrote must pass the check, however the file is chunked
+        writeFile( fileName, onDisk );
+        for ( auto numChunks = 1ULL; numChunks <= ( onDisk.length() + 1 ); ++numChunks )
+        {
+            auto result = runCaptured( { "appName.exe", "-c", fileName }, {}, [ numChunks ]( CSettings &settings ) { settings.setCheckChunks( numChunks ); } );
+            EXPECT_EQ( 0, result.fExitCode ) << numChunks << " chunks";
+            EXPECT_EQ( "", result.fErr ) << numChunks << " chunks";
+        }
+        std::remove( fileName.c_str() );
+    }
+
+    TEST( TestSort, Batch10 )
+    {
+        auto first = std::string( "alluniquecells.txt:batch10/report_cells.txt:  PSEUDOCELL OAOAOAI211111 Ia2.0b2.0c2.0d2.0e2.0f2.0 {>A,0},{>B,1},{>C,2},{>D,3},{>E,4},{>F,5},{>G,6},{<H,7:Ia2.0b2.0c2.0d2.0e2.0f2.0}\n" );
+        auto second = std::string( "alluniquecells.txt:batch10/report_cells.txt:  PSEUDOCELL AOAOAOI211111 a2.1b2.1c2.1d2.1e2.1f2.2 {>E,0},{>H,1},{>D,2},{>A,3},{>F,4},{>B,5},{>C,6},{<G,7:a2.1b2.1c2.1d2.1e2.1f2.2}\n" );
+        auto input = first + second + first;
+
+        auto fileName = std::string( "TestBatch10.txt" );
+        writeFile( fileName, input );
+
+        auto result = runCaptured( { "appName.exe", fileName } );
+        EXPECT_EQ( 0, result.fExitCode );
+        EXPECT_EQ( second + first, result.fOut );
+        EXPECT_EQ( "", result.fErr );
+
+        EXPECT_EQ( result.fOut, runCaptured( { "appName.exe" }, input ).fOut );
+        EXPECT_EQ( second + first, runCaptured( { "appName.exe", "-k", "2", fileName } ).fOut );
+        EXPECT_EQ( second + first, runCaptured( { "appName.exe", "-t", ":", "-k", "2", fileName } ).fOut );
+        EXPECT_EQ( first + second, runCaptured( { "appName.exe", "-k", "4", fileName } ).fOut );
+
+        // every line shares the PSEUDOCELL column, so -u keeps only the first one read, without it they sort as whole lines
+        EXPECT_EQ( first, runCaptured( { "appName.exe", "-k", "1", "-u", fileName } ).fOut );
+        EXPECT_EQ( second + first, runCaptured( { "appName.exe", "-k", "1", fileName } ).fOut );
+
+        std::remove( fileName.c_str() );
+    }
 }
 
 int main( int argc, char **argv )
@@ -0,0 +1,99 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "HyperLogLog.h"
+
+#include <cmath>
+
+CHyperLogLog::CHyperLogLog( uint8_t precision ) :
+    fPrecision( precision )
+{
+    if ( fPrecision < 4 )
+        fPrecision = 4;
+    else if ( fPrecision > 18 )
+        fPrecision = 18;
+    fRegisters.resize( 1ULL << fPrecision, 0 );
+}
+
+uint64_t CHyperLogLog::hash( const std::string &value )
+{
+    // FNV-1a followed by the splitmix64 finalizer, so short keys still spread over all 64 bits
+    uint64_t retVal = 0xcbf29ce484222325ULL;
+    for ( auto &&ch : value )
+    {
+        retVal ^= static_cast< uint8_t >( ch );
+        retVal *= 0x100000001b3ULL;
+    }
+    retVal ^= retVal >> 30;
+    retVal *= 0xbf58476d1ce4e5b9ULL;
+    retVal ^= retVal >> 27;
+    retVal *= 0x94d049bb133111ebULL;
+    retVal ^= retVal >> 31;
+    return retVal;
+}
+
+void CHyperLogLog::add( const std::string &value )
+{
+    addHash( hash( value ) );
+}
+
+void CHyperLogLog::addHash( uint64_t hash )
+{
+    fNumAdded++;
+    auto index = hash >> ( 64 - fPrecision );
+    auto remaining = ( hash << fPrecision ) | ( 1ULL << ( fPrecision - 1 ) );   // guard bit caps the rank
+
+    uint8_t rank = 1;
+    while ( ( remaining & ( 1ULL << 63 ) ) == 0 )
+    {
+        rank++;
+        remaining <<= 1;
+    }
+    if ( rank > fRegisters[ index ] )
+        fRegisters[ index ] = rank;
+}
+
+double CHyperLogLog::estimate() const
+{
+    auto numRegisters = static_cast< double >( fRegisters.size() );
+    double alpha = 0.7213 / ( 1.0 + 1.079 / numRegisters );
+    if ( fRegisters.size() == 16 )
+        alpha = 0.673;
+    else if ( fRegisters.size() == 32 )
+        alpha = 0.697;
+    else if ( fRegisters.size() == 64 )
+        alpha = 0.709;
+
+    double sum = 0.0;
+    std::size_t numZero = 0;
+    for ( auto &&reg : fRegisters )
+    {
+        sum += std::ldexp( 1.0, -reg );
+        if ( reg == 0 )
+            numZero++;
+    }
+
+    auto retVal = alpha * numRegisters * numRegisters / sum;
+    if ( ( retVal <= 2.5 * numRegisters ) && ( numZero != 0 ) )
+        retVal = numRegisters * std::log( numRegisters / static_cast< double >( numZero ) );   // linear counting for small sets
+    return retVal;
+}
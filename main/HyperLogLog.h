@@ -0,0 +1,49 @@
+#ifndef __HYPERLOGLOG_H
+#define __HYPERLOGLOG_H
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Fixed memory distinct count estimator, used to size the sort before the full input is read
+class CHyperLogLog
+{
+public:
+    CHyperLogLog( uint8_t precision = 14 );
+
+    void add( const std::string &value );
+    void addHash( uint64_t hash );
+
+    double estimate() const;
+    uint64_t numAdded() const { return fNumAdded; }
+
+    static uint64_t hash( const std::string &value );
+
+private:
+    uint8_t fPrecision{ 14 };
+    uint64_t fNumAdded{ 0 };
+    std::vector< uint8_t > fRegisters;
+};
+
+#endif
@@ -0,0 +1,472 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Server.h"
+#include "Settings.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+int runServer( const std::string & /*socketPath*/, uint64_t /*maxJobs*/, const std::function< void() > & /*onListening*/ )
+{
+    std::cerr << "--serve is not supported on this platform" << std::endl;
+    return 1;
+}
+
+int runClient( const std::string & /*socketPath*/, const std::vector< std::string > & /*args*/, bool /*sendStdin*/ )
+{
+    std::cerr << "--connect is not supported on this platform" << std::endl;
+    return 1;
+}
+#else
+namespace
+{
+    using TClock = std::chrono::steady_clock;
+    constexpr auto kNoDeadline{ TClock::time_point::max() };
+
+    // limits on what a client may ask the server to allocate before the job starts
+    constexpr uint64_t kMaxArgs{ 4096 };
+    constexpr uint64_t kMaxArgLength{ 64 * 1024 };
+    // the server keeps each job's input and output in memory, larger inputs are better sorted standalone
+    constexpr uint64_t kMaxInputLength{ 256 * 1024 * 1024 };
+    constexpr std::size_t kReadChunkBytes{ 64 * 1024 };
+    // the client has all of its input in hand before it connects, so a request or reply taking longer than this in total is a dead client
+    constexpr int kTimeoutSeconds{ 30 };
+    constexpr std::size_t kMinWorkers{ 4 };
+
+    // waits for fd to be ready, false once the deadline passes
+    bool waitFor( int fd, short events, TClock::time_point deadline )
+    {
+        while ( true )
+        {
+            auto timeoutMS = -1;
+            if ( deadline != kNoDeadline )
+            {
+                auto remaining = std::chrono::duration_cast< std::chrono::milliseconds >( deadline - TClock::now() ).count();
+                if ( remaining <= 0 )
+                    return false;
+                timeoutMS = static_cast< int >( std::min< decltype( remaining ) >( remaining, std::numeric_limits< int >::max() ) );
+            }
+
+            pollfd pollFD{ fd, events, 0 };
+            auto numReady = ::poll( &pollFD, 1, timeoutMS );
+            if ( numReady > 0 )
+                return true;
+            if ( ( numReady < 0 ) && ( errno == EINTR ) )
+                continue;
+            return false;
+        }
+    }
+
+#ifdef MSG_NOSIGNAL
+    constexpr int kNoSigPipe{ MSG_NOSIGNAL };
+#else
+    constexpr int kNoSigPipe{ 0 };   // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+    // a peer going away must fail the write, not raise SIGPIPE and kill the process
+    void disableSigPipe( int fd )
+    {
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        ::setsockopt( fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof( on ) );
+#else
+        (void)fd;
+#endif
+    }
+
+    bool retryable()
+    {
+        return ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR );
+    }
+
+    bool writeAll( int fd, const void *data, std::size_t length, TClock::time_point deadline )
+    {
+        auto curr = static_cast< const char * >( data );
+        while ( length )
+        {
+            if ( !waitFor( fd, POLLOUT, deadline ) )
+                return false;
+            auto written = ::send( fd, curr, length, MSG_DONTWAIT | kNoSigPipe );
+            if ( ( written < 0 ) && retryable() )
+                continue;
+            if ( written <= 0 )
+                return false;
+            curr += written;
+            length -= written;
+        }
+        return true;
+    }
+
+    bool readAll( int fd, void *data, std::size_t length, TClock::time_point deadline )
+    {
+        auto curr = static_cast< char * >( data );
+        while ( length )
+        {
+            if ( !waitFor( fd, POLLIN, deadline ) )
+                return false;
+            auto numRead = ::recv( fd, curr, length, MSG_DONTWAIT );
+            if ( ( numRead < 0 ) && retryable() )
+                continue;
+            if ( numRead <= 0 )
+                return false;
+            curr += numRead;
+            length -= numRead;
+        }
+        return true;
+    }
+
+    bool writeValue( int fd, uint64_t value, TClock::time_point deadline )
+    {
+        return writeAll( fd, &value, sizeof( value ), deadline );
+    }
+
+    bool readValue( int fd, uint64_t &value, TClock::time_point deadline )
+    {
+        return readAll( fd, &value, sizeof( value ), deadline );
+    }
+
+    bool writeString( int fd, const std::string &value, TClock::time_point deadline )
+    {
+        return writeValue( fd, value.length(), deadline ) && writeAll( fd, value.data(), value.length(), deadline );
+    }
+
+    bool readString( int fd, std::string &value, uint64_t maxLength, TClock::time_point deadline )
+    {
+        uint64_t length = 0;
+        if ( !readValue( fd, length, deadline ) || ( length > maxLength ) )
+            return false;
+
+        // the length is only what the peer claims, memory grows with the bytes that actually arrive
+        value.clear();
+        char buffer[ kReadChunkBytes ];
+        while ( value.length() < length )
+        {
+            auto chunkLength = static_cast< std::size_t >( std::min< uint64_t >( length - value.length(), sizeof( buffer ) ) );
+            if ( !readAll( fd, buffer, chunkLength, deadline ) )
+                return false;
+            value.append( buffer, chunkLength );
+        }
+        return true;
+    }
+
+    bool getAddress( const std::string &socketPath, sockaddr_un &addr )
+    {
+        std::memset( &addr, 0, sizeof( addr ) );
+        addr.sun_family = AF_UNIX;
+        if ( socketPath.length() >= sizeof( addr.sun_path ) )
+        {
+            std::cerr << "Socket path '" << socketPath << "' is too long" << std::endl;
+            return false;
+        }
+        std::strncpy( addr.sun_path, socketPath.c_str(), sizeof( addr.sun_path ) - 1 );
+        return true;
+    }
+
+    // Protocol, all integers are native uint64_t since both ends are on the same host
+    // client: numArgs, args..., working dir
+    // server: 1 if the job reads stdin, 0 otherwise
+    // client: (stdin contents)
+    // server: exit code, stdout contents, stderr contents
+    // returns false when the connection should be dropped without a reply
+    bool runJob( int fd, std::ostream &out, std::ostream &err, uint64_t &exitCode, bool &canReply )
+    {
+        // the whole request shares one deadline, a client trickling bytes can not hold a worker any longer than a silent one
+        auto deadline = TClock::now() + std::chrono::seconds( kTimeoutSeconds );
+        uint64_t numArgs = 0;
+        if ( !readValue( fd, numArgs, deadline ) || ( numArgs > kMaxArgs ) )
+            return false;
+
+        std::vector< std::string > args( numArgs );
+        for ( auto &&arg : args )
+        {
+            if ( !readString( fd, arg, kMaxArgLength, deadline ) )
+                return false;
+        }
+        std::string workingDir;
+        if ( !readString( fd, workingDir, kMaxArgLength, deadline ) )
+            return false;
+
+        // jobs run concurrently, each on its own streams and resolving file names against the client's working dir
+        std::istringstream in;
+        std::unique_ptr< CSettings > settings;
+        std::error_code ec;
+        if ( !std::filesystem::is_directory( workingDir, ec ) )
+            err << "Could not change to directory '" << workingDir << "'" << std::endl;
+        else
+        {
+            settings = std::make_unique< CSettings >( args, out, err, in, workingDir );
+            if ( settings->serve() || settings->connect() )
+            {
+                err << "--serve and --connect can not be forwarded to a server" << std::endl;
+                settings.reset();
+            }
+        }
+
+        auto needStdin = settings && settings->aOK() && ( settings->numFiles() == 0 );
+        std::string input;
+        if ( !writeValue( fd, needStdin ? 1 : 0, deadline ) || ( needStdin && !readString( fd, input, kMaxInputLength, deadline ) ) )
+            return false;
+
+        canReply = true;
+        if ( settings )
+        {
+            in.str( std::move( input ) );
+            exitCode = settings->run();
+        }
+        return true;
+    }
+
+    void runJob( int fd )
+    {
+        std::ostringstream out;
+        std::ostringstream err;
+        uint64_t exitCode = 1;
+        auto canReply = false;
+        try
+        {
+            if ( !runJob( fd, out, err, exitCode, canReply ) )
+                return;
+        }
+        catch ( std::exception &e )
+        {
+            err << "sabsort server: " << e.what() << '\n';
+            exitCode = 1;
+        }
+        catch ( ... )
+        {
+            err << "sabsort server: unknown error" << '\n';
+            exitCode = 1;
+        }
+
+        if ( canReply )
+        {
+            auto deadline = TClock::now() + std::chrono::seconds( kTimeoutSeconds );
+            writeValue( fd, exitCode, deadline ) && writeString( fd, out.str(), deadline ) && writeString( fd, err.str(), deadline );
+        }
+    }
+
+    // a fixed set of threads started with the server, each connection is served by whichever one is free
+    // a stalled client ties up one worker until its deadline, the others keep serving
+    class CWorkerPool
+    {
+    public:
+        CWorkerPool( std::size_t numWorkers )
+        {
+            for ( auto ii = 0ULL; ii < numWorkers; ++ii )
+                fWorkers.emplace_back( [ this ]() { work(); } );
+        }
+
+        ~CWorkerPool()
+        {
+            {
+                std::lock_guard< std::mutex > lock( fMutex );
+                fDone = true;
+            }
+            fReady.notify_all();
+            for ( auto &&worker : fWorkers )
+                worker.join();
+        }
+
+        void add( int clientFD )
+        {
+            {
+                std::lock_guard< std::mutex > lock( fMutex );
+                fPending.push_back( clientFD );
+            }
+            fReady.notify_one();
+        }
+
+    private:
+        // drains the pending connections before stopping
+        void work()
+        {
+            while ( true )
+            {
+                int clientFD = -1;
+                {
+                    std::unique_lock< std::mutex > lock( fMutex );
+                    fReady.wait( lock, [ this ]() { return fDone || !fPending.empty(); } );
+                    if ( fPending.empty() )
+                        return;
+                    clientFD = fPending.front();
+                    fPending.pop_front();
+                }
+                runJob( clientFD );
+                ::close( clientFD );
+            }
+        }
+
+        std::mutex fMutex;
+        std::condition_variable fReady;
+        std::deque< int > fPending;
+        bool fDone{ false };
+        std::vector< std::thread > fWorkers;
+    };
+
+    // refuses to replace anything but a stale socket
+    bool removeStaleSocket( const std::string &socketPath, const sockaddr_un &addr )
+    {
+        struct stat info;
+        if ( ::lstat( socketPath.c_str(), &info ) != 0 )
+            return true;
+
+        if ( !S_ISSOCK( info.st_mode ) )
+        {
+            std::cerr << "'" << socketPath << "' exists and is not a socket" << std::endl;
+            return false;
+        }
+
+        auto probeFD = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+        auto inUse = ( probeFD >= 0 ) && ( ::connect( probeFD, reinterpret_cast< const sockaddr * >( &addr ), sizeof( addr ) ) == 0 );
+        if ( probeFD >= 0 )
+            ::close( probeFD );
+        if ( inUse )
+        {
+            std::cerr << "A server is already running on '" << socketPath << "'" << std::endl;
+            return false;
+        }
+        ::unlink( socketPath.c_str() );
+        return true;
+    }
+}
+
+int runServer( const std::string &socketPath, uint64_t maxJobs, const std::function< void() > &onListening )
+{
+    sockaddr_un addr;
+    if ( !getAddress( socketPath, addr ) || !removeStaleSocket( socketPath, addr ) )
+        return 1;
+
+    auto serverFD = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( serverFD < 0 )
+    {
+        std::cerr << "Could not create socket: " << std::strerror( errno ) << std::endl;
+        return 1;
+    }
+
+    if ( ( ::bind( serverFD, reinterpret_cast< sockaddr * >( &addr ), sizeof( addr ) ) != 0 ) || ( ::listen( serverFD, 64 ) != 0 ) )
+    {
+        std::cerr << "Could not listen on '" << socketPath << "': " << std::strerror( errno ) << std::endl;
+        ::close( serverFD );
+        return 1;
+    }
+
+    if ( onListening )
+        onListening();
+
+    uint64_t numJobs = 0;
+    {
+        CWorkerPool workers( std::max( kMinWorkers, static_cast< std::size_t >( std::thread::hardware_concurrency() ) ) );
+        while ( ( maxJobs == 0 ) || ( numJobs < maxJobs ) )
+        {
+            auto clientFD = ::accept( serverFD, nullptr, nullptr );
+            if ( clientFD < 0 )
+            {
+                if ( errno == EINTR )
+                    continue;
+                std::cerr << "Could not accept connection: " << std::strerror( errno ) << std::endl;
+                break;
+            }
+            disableSigPipe( clientFD );
+            workers.add( clientFD );
+            numJobs++;
+        }
+    }
+    ::close( serverFD );
+    ::unlink( socketPath.c_str() );
+    return ( ( maxJobs != 0 ) && ( numJobs == maxJobs ) ) ? 0 : 1;
+}
+
+int runClient( const std::string &socketPath, const std::vector< std::string > &args, bool sendStdin )
+{
+    sockaddr_un addr;
+    if ( !getAddress( socketPath, addr ) )
+        return 1;
+
+    // read before connecting, a slow producer must not hold a server worker
+    std::string input;
+    if ( sendStdin )
+        input.assign( std::istreambuf_iterator< char >( std::cin ), {} );
+    if ( input.length() > kMaxInputLength )
+    {
+        std::cerr << "Input is larger than the server accepts (" << kMaxInputLength << " bytes), run sabsort without --connect" << std::endl;
+        return 1;
+    }
+
+    auto fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( ( fd < 0 ) || ( ::connect( fd, reinterpret_cast< sockaddr * >( &addr ), sizeof( addr ) ) != 0 ) )
+    {
+        std::cerr << "Could not connect to '" << socketPath << "': " << std::strerror( errno ) << std::endl;
+        if ( fd >= 0 )
+            ::close( fd );
+        return 1;
+    }
+    disableSigPipe( fd );
+
+    // the job itself may take as long as it needs, the server enforces the deadlines
+    auto aOK = writeValue( fd, args.size(), kNoDeadline );
+    for ( auto ii = 0ULL; aOK && ( ii < args.size() ); ++ii )
+        aOK = writeString( fd, args[ ii ], kNoDeadline );
+    aOK = aOK && writeString( fd, std::filesystem::current_path().string(), kNoDeadline );
+
+    uint64_t needStdin = 0;
+    aOK = aOK && readValue( fd, needStdin, kNoDeadline );
+    if ( aOK && needStdin )
+        aOK = writeString( fd, input, kNoDeadline );
+
+    uint64_t exitCode = 1;
+    std::string out;
+    std::string err;
+    aOK = aOK && readValue( fd, exitCode, kNoDeadline ) && readString( fd, out, -1 * 1ULL, kNoDeadline ) && readString( fd, err, -1 * 1ULL, kNoDeadline );
+    ::close( fd );
+    if ( !aOK )
+    {
+        std::cerr << "Lost connection to '" << socketPath << "'" << std::endl;
+        return 1;
+    }
+
+    std::cout << out;
+    std::cerr << err;
+    return static_cast< int >( exitCode );
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef __SERVER_H
+#define __SERVER_H
+// The MIT License( MIT )
+//
+// Copyright( c ) 2024 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// --serve: accept jobs on a local unix socket, running each one exactly as a standalone sabsort would
+// jobs run concurrently on a pool of worker threads started with the server
+// maxJobs of 0 serves forever, onListening is called once the socket accepts connections
+int runServer( const std::string &socketPath, uint64_t maxJobs = 0, const std::function< void() > &onListening = {} );
+// --connect: forward the command line to a running server, along with stdin when sendStdin is set (no input files)
+int runClient( const std::string &socketPath, const std::vector< std::string > &args, bool sendStdin );
+
+#endif
@@ -22,11 +22,16 @@
 
 #include "Settings.h"
 #include "Utils.h"
+#include "HyperLogLog.h"
 
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <map>
 #include <set>
-#include< list >
+#include <thread>
+#include <unordered_map>
 
 CSettings::CSettings( int argc, char **argv )
 {
@@ -50,10 +55,19 @@ CSettings::CSettings( const std::vector< const char * > &args )
     init( stringArgs );
 }
 
+CSettings::CSettings( const std::vector< std::string > &args, std::ostream &out, std::ostream &err, std::istream &in, const std::string &workingDir ) :
+    fOut( &out ),
+    fErr( &err ),
+    fIn( &in ),
+    fWorkingDir( workingDir )
+{
+    init( args );
+}
+
 void CSettings::init( const std::vector< std::string > &args )
 {
     fAOK = true;
-    for ( auto ii = 1ULL; ii < args.size(); ++ii )
+    for ( std::size_t ii = 1; ii < args.size(); ++ii )
     {
         auto lastArg = ( ii == ( args.size() - 1 ) );
         auto currArg = args[ ii ];
@@ -63,7 +77,33 @@ void CSettings::init( const std::vector< std::string > &args )
         //std::cout << "currArg: " << ( currArg ) << "\n";
         //std::cout << "nextArg: " << ( nextArg ) << "\n";
 
-        if ( currArg.compare( 0, 2, "-u" ) == 0 )
+        if ( ( currArg == "--serve" ) || ( currArg == "--connect" ) )
+        {
+            if ( lastArg )
+            {
+                showHelp( *fOut );
+                fAOK = false;
+                return;
+            }
+            if ( currArg == "--serve" )
+                fServeSocket = nextArg;
+            else
+            {
+                fConnectSocket = nextArg;
+                fForwardArgs = args;
+                fForwardArgs.erase( fForwardArgs.begin() + ii, fForwardArgs.begin() + ii + 2 );
+            }
+            ii++;
+        }
+        else if ( currArg == "--plan" )
+        {
+            fShowPlan = true;
+        }
+        else if ( currArg.compare( 0, 2, "-c" ) == 0 )
+        {
+            fCheckOnly = true;
+        }
+        else if ( currArg.compare( 0, 2, "-u" ) == 0 )
         {
             fUnique = true;
         }
@@ -71,7 +111,7 @@ void CSettings::init( const std::vector< std::string > &args )
         {
             if ( ( currArg.length() == 2 ) && lastArg )
             {
-                showHelp();
+                showHelp( *fOut );
                 fAOK = false;
                 return;
             }
@@ -81,10 +121,10 @@ void CSettings::init( const std::vector< std::string > &args )
             //{
             //    std::cout << "args[" << ii << "] = {" << args[ ii ] << "}\n";
             //}
-            fSeparator = getSeparator( ii, args );
+            fSeparator = getSeparator( ii, args, *fErr );
             if ( fSeparator == 0 )
             {
-                showHelp();
+                showHelp( *fOut );
                 fAOK = false;
                 return;
             }
@@ -93,7 +133,7 @@ void CSettings::init( const std::vector< std::string > &args )
         {
             if ( ( currArg.length() == 2 ) && lastArg )
             {
-                showHelp();
+                showHelp( *fOut );
                 fAOK = false;
                 return;
             }
@@ -114,36 +154,56 @@ void CSettings::init( const std::vector< std::string > &args )
             }
             catch ( ... )
             {
-                std::cerr << "Invalid argument: column must be an integer." << '\n';
-                showHelp();
+                *fErr << "Invalid argument: column must be an integer." << '\n';
+                showHelp( *fOut );
             }
         }
         else
             fFileNames.emplace_back( currArg );
     }
-    createStreams();
+    if ( serve() && connect() )
+    {
+        *fErr << "--serve and --connect can not be used together." << '\n';
+        showHelp( *fOut );
+        fAOK = false;
+        return;
+    }
+    if ( !serve() && !connect() )
+        createStreams();
 }
 
 void CSettings::showHelp()
 {
-    std::cout << "Usage unique_sort [-t char] [-k column] [-u] inputfile" << std::endl;
+    showHelp( std::cout );
+}
+
+void CSettings::showHelp( std::ostream &oss )
+{
+    oss << "Usage unique_sort [-t char] [-k column] [-u] [-c] [--plan] inputfile" << std::endl;
+    oss << "      unique_sort --serve socket" << std::endl;
+    oss << "      unique_sort --connect socket [-t char] [-k column] [-u] [-c] [--plan] inputfile" << std::endl;
 }
 
 void CSettings::createStreams()
 {
     if ( fFileNames.empty() )
     {
-        fStreams.push_back( &std::cin );
+        fStreams.push_back( fIn );
     }
     else
     {
         for ( auto &&fileName : fFileNames )
         {
-            auto stream = new std::ifstream( fileName );
+            auto path = std::filesystem::path( fileName );
+            if ( !fWorkingDir.empty() && path.is_relative() )
+                path = std::filesystem::path( fWorkingDir ) / path;
+            fFilePaths.emplace_back( path.string() );
+
+            auto stream = new std::ifstream( fFilePaths.back() );
             if ( !stream->is_open() )
             {
-                std::cerr << "Could not open file '" << fileName << "'" << std::endl;
-                showHelp();
+                *fErr << "Could not open file '" << fileName << "'" << std::endl;
+                showHelp( *fOut );
                 fAOK = false;
                 return;
             }
@@ -161,63 +221,402 @@ void CSettings::dump() const
 {
     return;
 
-    std::cout << "Files: ";
+    *fOut << "Files: ";
     if ( fFileNames.empty() )
-        std::cout << "<stdin>";
+        *fOut << "<stdin>";
     auto first = true;
     for ( auto &&ii : fFileNames )
     {
         if ( !first )
-            std::cout << ", ";
+            *fOut << ", ";
         first = false;
-        std::cout << ii;
+        *fOut << ii;
     }
-    std::cout << "\n";
+    *fOut << "\n";
 }
 
-bool CSettings::process() const
+bool CSettings::getKey( const std::string &line, std::string &key ) const
 {
-    if ( !aOK() )
+    if ( fSortColumn == -1 )
+    {
+        key = line;
+        return true;
+    }
+
+    auto split = splitLine( line, false, fSeparator );
+    if ( split.empty() )
         return false;
 
-    std::map< std::string, std::set< std::string > > lines;
+    auto columnToSort = fSortColumn;
+    if ( fSortColumn >= split.size() )
+        columnToSort = 0;
+    key = split[ columnToSort ];
+    return true;
+}
+
+void SExecutionPlan::dump( std::ostream &oss ) const
+{
+    oss << "Plan: " << ( ( fPlan == EExecutionPlan::eHashTable ) ? "hash table" : "ordered map" ) << "\n";
+    oss << "    Sampled Lines: " << fSampledLines << "\n";
+    oss << "    Sampled Bytes: " << fSampledBytes << "\n";
+    oss << "    Total Bytes: ";
+    if ( fTotalBytes == 0 )
+        oss << "<unknown>";
+    else
+        oss << fTotalBytes;
+    oss << "\n";
+    oss << "    Average Line Length: " << fAvgLineLength << "\n";
+    oss << "    Estimated Lines: " << fEstimatedLines;
+    if ( !fExact )
+        oss << ( ( fTotalBytes == 0 ) ? " (lower bound)" : " (extrapolated)" );
+    oss << "\n";
+    oss << "    Estimated Distinct Keys: " << fEstimatedKeys << "\n";
+}
+
+// Fits the distinct count of n uniform draws from C keys, D( n ) = C * ( 1 - e^( -n / C ) ), to the sample and projects it to numLines.
+// New keys slow down as the input repeats itself, rather than arriving at the sample's rate forever.
+// Skewed keys come out low, which only costs rehashing, where a high estimate costs memory.
+uint64_t CSettings::extrapolateKeys( uint64_t sampledKeys, uint64_t sampledLines, uint64_t numLines )
+{
+    if ( ( sampledLines == 0 ) || ( numLines <= sampledLines ) )
+        return sampledKeys;
+    if ( sampledKeys >= sampledLines )
+        return numLines;   // no repeats seen, nothing to fit
+
+    auto distinct = []( double cardinality, double lines ) { return cardinality * -std::expm1( -lines / cardinality ); };
+
+    // D( n ) grows with C, bisect in log space between sampledKeys and a bound well past any real input
+    auto low = std::log( static_cast< double >( sampledKeys ) );
+    auto high = std::log( static_cast< double >( sampledKeys ) ) + 64.0;
+    for ( auto ii = 0; ii < 100; ++ii )
+    {
+        auto mid = ( low + high ) / 2;
+        if ( distinct( std::exp( mid ), static_cast< double >( sampledLines ) ) < sampledKeys )
+            low = mid;
+        else
+            high = mid;
+    }
+    auto retVal = static_cast< uint64_t >( distinct( std::exp( high ), static_cast< double >( numLines ) ) + 0.5 );
+    return std::min( std::max( retVal, sampledKeys ), numLines );
+}
+
+// reads up to kSampleBytes of the first stream into sample, and sketches the key cardinality from it
+SExecutionPlan CSettings::computePlan( std::vector< std::string > &sample ) const
+{
+    SExecutionPlan retVal;
+    if ( fStreams.empty() )
+        return retVal;
+
+    CHyperLogLog hll;
+    CHyperLogLog lineHLL;   // exact repeats of a line say nothing about how fast new keys arrive
+    auto stream = fStreams.front();
+    std::string key;
+    for ( std::string line; ( retVal.fSampledBytes < kSampleBytes ) && std::getline( *stream, line, '\n' ); )
+    {
+        retVal.fSampledLines++;
+        retVal.fSampledBytes += line.length() + 1;
+        if ( getKey( line, key ) )
+            hll.add( key );
+        lineHLL.add( line );
+        sample.emplace_back( std::move( line ) );
+    }
+    retVal.fExact = stream->eof() && ( fStreams.size() == 1 );
+
+    for ( auto &&fileName : fFilePaths )
+    {
+        std::error_code ec;
+        auto size = std::filesystem::file_size( fileName, ec );
+        if ( !ec )
+            retVal.fTotalBytes += size;
+    }
+
+    if ( retVal.fSampledLines == 0 )
+        return retVal;
+
+    retVal.fAvgLineLength = static_cast< double >( retVal.fSampledBytes ) / retVal.fSampledLines - 1;
+    auto sampledKeys = std::min( static_cast< uint64_t >( hll.estimate() + 0.5 ), retVal.fSampledLines );
+    if ( retVal.fExact || ( retVal.fTotalBytes <= retVal.fSampledBytes ) )
+    {
+        retVal.fEstimatedLines = retVal.fSampledLines;
+        retVal.fEstimatedKeys = sampledKeys;
+    }
+    else
+    {
+        // assume the rest of the input has the same line length as the sample
+        retVal.fEstimatedLines = static_cast< uint64_t >( retVal.fTotalBytes / ( retVal.fAvgLineLength + 1 ) );
+        // fit on distinct lines only, scaling the total by the same fraction of repeated lines
+        auto sampledDistinctLines = std::max( std::min( static_cast< uint64_t >( lineHLL.estimate() + 0.5 ), retVal.fSampledLines ), sampledKeys );
+        auto distinctLines = static_cast< uint64_t >( static_cast< double >( retVal.fEstimatedLines ) * sampledDistinctLines / retVal.fSampledLines );
+        retVal.fEstimatedKeys = extrapolateKeys( sampledKeys, sampledDistinctLines, distinctLines );
+    }
+
+    // when the input size is unknown, the sample being full is itself the hint the input is large
+    auto keysForPlan = retVal.fEstimatedKeys;
+    if ( ( retVal.fTotalBytes == 0 ) && !retVal.fExact && ( retVal.fSampledBytes >= kSampleBytes ) )
+        keysForPlan = std::max( keysForPlan, kHashTableThreshold );
+    if ( keysForPlan >= kHashTableThreshold )
+        retVal.fPlan = EExecutionPlan::eHashTable;
+    return retVal;
+}
+
+template< typename T >
+void CSettings::readLines( T &lines, std::vector< std::string > &sample ) const
+{
+    std::string key;
+    auto addLine = [ & ]( std::string &&line )
+    {
+        if ( !getKey( line, key ) )
+            return;
+
+        if ( ( fSortColumn != -1 ) && fUnique )
+        {
+            auto pos = lines.find( key );
+            if ( pos != lines.end() )
+                return;
+        }
+        lines[ key ].emplace( std::move( line ) );
+    };
+
+    for ( auto &&line : sample )
+        addLine( std::move( line ) );
+    sample.clear();
+
     for ( auto &&stream : fStreams )
     {
-        std::size_t lineNum = 0;
-        for ( std::string line; std::getline( *stream, line, '\n' ); ++lineNum )
+        for ( std::string line; std::getline( *stream, line, '\n' ); )
+            addLine( std::move( line ) );
+        if ( deleteStreams() )
+            delete stream;
+    }
+}
+
+int CSettings::run() const
+{
+    if ( !aOK() )
+        return 1;
+
+    dump();
+
+    return process() ? 0 : 1;
+}
+
+struct SCheckChunk
+{
+    uint64_t fNumLines{ 0 };
+    bool fHasKeys{ false };   // at least one line in the chunk has a sort key
+    uint64_t fFirstLineNum{ 0 };   // 1 based, within the chunk
+    std::string fFirstKey;
+    std::string fFirstLine;
+    std::string fLastKey;
+    std::string fLastLine;
+    uint64_t fViolationLineNum{ 0 };   // 0 when the chunk is in order, the line count stops here otherwise
+    std::string fViolation;
+    bool fOpenFailed{ false };
+};
+
+// matches the order process() writes: by key, then by line, -u allows one line per key
+bool CSettings::inOrder( const std::string &prevKey, const std::string &prevLine, const std::string &currKey, const std::string &currLine, std::string &reason ) const
+{
+    if ( prevKey != currKey )
+    {
+        if ( currKey < prevKey )
+            reason = "disorder";
+        return prevKey < currKey;
+    }
+
+    if ( fUnique && ( fSortColumn != -1 ) )
+    {
+        reason = "duplicate";
+        return false;
+    }
+    if ( currLine < prevLine )
+    {
+        reason = "disorder";
+        return false;
+    }
+    if ( fUnique && ( currLine == prevLine ) )
+    {
+        reason = "duplicate";
+        return false;
+    }
+    return true;
+}
+
+// checks the lines that start in [start, end), only the first and last line are kept
+void CSettings::checkChunk( std::istream &stream, uint64_t start, uint64_t end, SCheckChunk &chunk ) const
+{
+    auto pos = start;
+    if ( start != 0 )
+    {
+        // a line straddling the start belongs to the previous chunk
+        stream.seekg( start - 1 );
+        std::string partial;
+        std::getline( stream, partial, '\n' );
+        pos = start - 1 + partial.length() + 1;
+    }
+
+    std::string key;
+    for ( std::string line; ( pos < end ) && std::getline( stream, line, '\n' ); )
+    {
+        pos += line.length() + 1;
+#ifdef _WIN32
+        // the chunks are read in binary to keep the offsets exact, process() reads in text mode and never sees the '\r'
+        if ( !line.empty() && ( line.back() == '\r' ) )
+            line.pop_back();
+#endif
+        chunk.fNumLines++;
+        if ( !getKey( line, key ) )
+            continue;
+
+        if ( !chunk.fHasKeys )
+        {
+            chunk.fHasKeys = true;
+            chunk.fFirstLineNum = chunk.fNumLines;
+            chunk.fFirstKey = key;
+            chunk.fFirstLine = line;
+        }
+        else if ( !inOrder( chunk.fLastKey, chunk.fLastLine, key, line, chunk.fViolation ) )
+        {
+            chunk.fViolationLineNum = chunk.fNumLines;
+            chunk.fLastLine = line;
+            return;
+        }
+        std::swap( chunk.fLastKey, key );
+        std::swap( chunk.fLastLine, line );
+    }
+}
+
+bool CSettings::check() const
+{
+    auto aOK = true;
+    for ( auto ii = 0ULL; aOK && ( ii < fStreams.size() ); ++ii )
+    {
+        std::vector< SCheckChunk > chunks;
+        if ( fFileNames.empty() )
+        {
+            chunks.resize( 1 );
+            checkChunk( *fStreams[ ii ], 0, -1 * 1ULL, chunks.front() );
+        }
+        else
         {
-            if ( fSortColumn == -1 )
+            // each thread opens its own stream, the lines at the chunk boundaries are compared afterwards
+            std::error_code ec;
+            auto size = std::filesystem::file_size( fFilePaths[ ii ], ec );
+            if ( ec )
             {
-                lines[ line ].emplace( line );
+                *fErr << "Could not open file '" << fFileNames[ ii ] << "'" << std::endl;
+                aOK = false;
+                break;
             }
-            else
+
+            uint64_t numChunks = fCheckChunks;
+            if ( numChunks == 0 )
+                numChunks = std::min( static_cast< uint64_t >( std::thread::hardware_concurrency() ), static_cast< uint64_t >( size / kMinCheckChunkBytes ) );
+            numChunks = std::max( static_cast< uint64_t >( 1 ), std::min( numChunks, static_cast< uint64_t >( size ) ) );
+            chunks.resize( numChunks );
+
+            std::vector< std::thread > threads;
+            for ( auto jj = 0ULL; jj < numChunks; ++jj )
             {
-                auto split = splitLine( line, false, fSeparator );
-                if ( split.empty() )
-                    continue;
-
-                auto columnToSort = fSortColumn;
-                if ( fSortColumn > split.size() )
-                    columnToSort = 0;
-                auto key = split[ columnToSort ];
-                if ( !fUnique )
-                    lines[ key ].emplace( line );
-                else
-                {
-                    auto pos = lines.find( key );
-                    if ( pos == lines.end() )
-                        lines[ key ].emplace( line );
-                }
-            }
-        };
-        if ( deleteStreams() )
+                auto start = size / numChunks * jj;
+                auto end = ( jj == ( numChunks - 1 ) ) ? -1 * 1ULL : ( size / numChunks * ( jj + 1 ) );
+                threads.emplace_back(
+                    [ this, ii, start, end, &chunk = chunks[ jj ] ]()
+                    {
+                        std::ifstream stream( fFilePaths[ ii ], std::ios::binary );
+                        if ( stream.is_open() )
+                            checkChunk( stream, start, end, chunk );
+                        else
+                            chunk.fOpenFailed = true;
+                    } );
+            }
+            for ( auto &&thread : threads )
+                thread.join();
+
+            if ( std::any_of( chunks.begin(), chunks.end(), []( auto &&chunk ) { return chunk.fOpenFailed; } ) )
+            {
+                *fErr << "Could not open file '" << fFileNames[ ii ] << "'" << std::endl;
+                aOK = false;
+                break;
+            }
+        }
+
+        auto fileName = fFileNames.empty() ? std::string( "-" ) : fFileNames[ ii ];
+        uint64_t lineOffset = 0;
+        const SCheckChunk *prev = nullptr;
+        for ( auto &&chunk : chunks )
+        {
+            std::string reason;
+            if ( prev && chunk.fHasKeys && !inOrder( prev->fLastKey, prev->fLastLine, chunk.fFirstKey, chunk.fFirstLine, reason ) )
+            {
+                *fErr << fileName << ":" << ( lineOffset + chunk.fFirstLineNum ) << ": " << reason << ": " << chunk.fFirstLine << '\n';
+                aOK = false;
+                break;
+            }
+            if ( chunk.fViolationLineNum != 0 )
+            {
+                *fErr << fileName << ":" << ( lineOffset + chunk.fViolationLineNum ) << ": " << chunk.fViolation << ": " << chunk.fLastLine << '\n';
+                aOK = false;
+                break;
+            }
+            lineOffset += chunk.fNumLines;
+            if ( chunk.fHasKeys )
+                prev = &chunk;
+        }
+    }
+
+    if ( deleteStreams() )
+    {
+        for ( auto &&stream : fStreams )
             delete stream;
     }
+    return aOK;
+}
+
+bool CSettings::process() const
+{
+    if ( !aOK() )
+        return false;
+
+    if ( fCheckOnly )
+        return check();
+
+    std::vector< std::string > sample;
+    auto plan = computePlan( sample );
+    if ( fForcedPlan )
+        plan.fPlan = *fForcedPlan;
+    if ( fShowPlan )
+        plan.dump( *fErr );
+
+    if ( plan.fPlan == EExecutionPlan::eHashTable )
+    {
+        std::unordered_map< std::string, std::set< std::string > > lines;
+        lines.reserve( std::min( plan.fEstimatedKeys, kMaxReservedKeys ) );
+        readLines( lines, sample );
+
+        std::vector< decltype( lines )::const_pointer > sorted;
+        sorted.reserve( lines.size() );
+        for ( auto &&ii : lines )
+            sorted.push_back( &ii );
+        std::sort( sorted.begin(), sorted.end(), []( auto lhs, auto rhs ) { return lhs->first < rhs->first; } );
+
+        for ( auto &&ii : sorted )
+        {
+            for ( auto &&line : ii->second )
+            {
+                *fOut << line << "\n";
+            }
+        }
+        return true;
+    }
+
+    std::map< std::string, std::set< std::string > > lines;
+    readLines( lines, sample );
     for ( auto &&[ key, currLines ] : lines )
     {
         for ( auto &&line : currLines )
         {
-            std::cout << line << "\n";
+            *fOut << line << "\n";
         }
     }
     return true;
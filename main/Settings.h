@@ -28,6 +28,29 @@
 #include <vector>
 #include <iostream>
 #include <cstdint>
+#include <optional>
+
+enum class EExecutionPlan
+{
+    eOrderedMap,   // few keys, std::map insertion is cheap enough
+    eHashTable     // many keys, reserve an unordered_map up front and sort the keys once at output
+};
+
+struct SExecutionPlan
+{
+    EExecutionPlan fPlan{ EExecutionPlan::eOrderedMap };
+    bool fExact{ false };   // the sample covered the whole input
+    uint64_t fSampledLines{ 0 };
+    uint64_t fSampledBytes{ 0 };
+    uint64_t fTotalBytes{ 0 };   // 0 when the input size is unknown (stdin)
+    double fAvgLineLength{ 0.0 };
+    uint64_t fEstimatedLines{ 0 };
+    uint64_t fEstimatedKeys{ 0 };
+
+    void dump( std::ostream &oss ) const;
+};
+
+struct SCheckChunk;
 
 class CSettings
 {
@@ -35,9 +58,13 @@ public:
     CSettings( int argc, char **argv );
     CSettings( const std::vector< std::string > &args );
     CSettings( const std::vector< const char * > &args );
+    // output, errors and stdin go to the given streams, relative file names resolve against workingDir
+    CSettings( const std::vector< std::string > &args, std::ostream &out, std::ostream &err, std::istream &in, const std::string &workingDir );
 
     static void showHelp();
+    static void showHelp( std::ostream &oss );
     bool process() const;
+    int run() const;
 
     bool aOK() const { return fAOK; }
     void dump() const;
@@ -46,9 +73,32 @@ public:
     bool unique() const { return fUnique; }
     uint64_t sortColumn() const { return fSortColumn; }
     char separator() const { return fSeparator; }
+    bool showPlan() const { return fShowPlan; }
+    void setPlan( EExecutionPlan plan ) { fForcedPlan = plan; }   // overrides the sampled choice, the output is the same either way
+    static uint64_t extrapolateKeys( uint64_t sampledKeys, uint64_t sampledLines, uint64_t numLines );
+    bool checkOnly() const { return fCheckOnly; }
+    void setCheckChunks( uint64_t numChunks ) { fCheckChunks = numChunks; }   // 0 picks from the file size and hardware threads
+
+    bool serve() const { return !fServeSocket.empty(); }
+    bool connect() const { return !fConnectSocket.empty(); }
+    const std::string &socketPath() const { return serve() ? fServeSocket : fConnectSocket; }
+    const std::vector< std::string > &forwardArgs() const { return fForwardArgs; }
+
+    static constexpr uint64_t kSampleBytes{ 4 * 1024 * 1024 };
+    static constexpr uint64_t kHashTableThreshold{ 4096 };
+    static constexpr uint64_t kMaxReservedKeys{ 4 * 1024 * 1024 };   // the estimate is a hint, never reserve more than this up front
+    static constexpr uint64_t kMinCheckChunkBytes{ 16 * 1024 * 1024 };
 
     private:
     void init( const std::vector< std::string > &args );
+    bool getKey( const std::string &line, std::string &key ) const;
+    SExecutionPlan computePlan( std::vector< std::string > &sample ) const;
+    template< typename T >
+    void readLines( T &lines, std::vector< std::string > &sample ) const;
+    bool check() const;
+    bool inOrder( const std::string &prevKey, const std::string &prevLine, const std::string &currKey, const std::string &currLine, std::string &reason ) const;
+    void checkChunk( std::istream &stream, uint64_t start, uint64_t end, SCheckChunk &chunk ) const;
+
     bool fAOK{ false };
     void createStreams();
     bool deleteStreams() const;
@@ -56,9 +106,22 @@ public:
     char fSeparator{ ' ' };
     uint64_t fSortColumn{ -1*1ULL };
     bool fUnique{ false };
+    bool fShowPlan{ false };
+    std::optional< EExecutionPlan > fForcedPlan;
+    bool fCheckOnly{ false };
+    uint64_t fCheckChunks{ 0 };
+    std::string fServeSocket;
+    std::string fConnectSocket;
+    std::vector< std::string > fForwardArgs;   // the command line minus --connect, sent to the server
     std::vector< std::string > fFileNames;
+    std::vector< std::string > fFilePaths;   // fFileNames resolved against fWorkingDir
     std::vector< std::istream * > fStreams;
 
+    std::ostream *fOut{ &std::cout };
+    std::ostream *fErr{ &std::cerr };
+    std::istream *fIn{ &std::cin };
+    std::string fWorkingDir;
+
 };
 
 #endif
\ No newline at end of file
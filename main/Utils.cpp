@@ -26,7 +26,7 @@
 #include <string>
 #include <vector>
 
-char getEscapedChar( const std::string &escaped )
+char getEscapedChar( const std::string &escaped, std::ostream &err )
 {
     if ( escaped.empty() )
         return 0;
@@ -84,12 +84,12 @@ char getEscapedChar( const std::string &escaped )
                 }
                 catch ( ... )
                 {
-                    std::cerr << "Invalid hex escape code: " << escaped << "\n";
+                    err << "Invalid hex escape code: " << escaped << "\n";
                     retVal = 0;
                 }
                 if ( ( pos != -1 ) && ( pos != ( escaped.length() - 1 ) ) )
                 {
-                    std::cerr << "Invalid hex escape code: " << escaped << "\n";
+                    err << "Invalid hex escape code: " << escaped << "\n";
                     retVal = 0;
                 }
                 break;
@@ -112,12 +112,12 @@ char getEscapedChar( const std::string &escaped )
                 }
                 catch ( ... )
                 {
-                    std::cerr << "Invalid octal escape code: " << escaped << "\n";
+                    err << "Invalid octal escape code: " << escaped << "\n";
                     retVal = 0;
                 }
                 if ( ( pos != -1 ) && ( pos != escaped.length() ) )
                 {
-                    std::cerr << "Invalid octal escape code: " << escaped << "\n";
+                    err << "Invalid octal escape code: " << escaped << "\n";
                     retVal = 0;
                 }
                 break;
@@ -130,7 +130,7 @@ char getEscapedChar( const std::string &escaped )
     return retVal;
 }
 
-char getSeparator( std::size_t &ii, const std::string &currArg, const std::string &nextArg, const std::string &nextNextArg, const std::string &nextNextNextArg, bool nested )
+char getSeparator( std::size_t &ii, const std::string &currArg, const std::string &nextArg, const std::string &nextNextArg, const std::string &nextNextNextArg, bool nested, std::ostream &err )
 {
     char separator = 0;
     if ( nested && currArg.length() == 1 )
@@ -147,7 +147,7 @@ char getSeparator( std::size_t &ii, const std::string &currArg, const std::strin
         else
         {
             ii++;
-            return getSeparator( ii, nextArg, nextNextArg, nextNextNextArg, "", true );
+            return getSeparator( ii, nextArg, nextNextArg, nextNextNextArg, "", true, err );
         }
     }
     else if ( currArg.length() == 3 )
@@ -168,7 +168,7 @@ char getSeparator( std::size_t &ii, const std::string &currArg, const std::strin
     }
     else if ( ( currArg.length() == 4 ) && ( currArg[ 2 ] == '\\' ) )
     {
-        separator = getEscapedChar( currArg.substr( 3 ) );
+        separator = getEscapedChar( currArg.substr( 3 ), err );
     }
     else if ( ( currArg.length() == 5 ) && ( currArg[ 2 ] == '\'' ) && ( currArg[ 4 ] == '\'' ) )
     {
@@ -177,23 +177,23 @@ char getSeparator( std::size_t &ii, const std::string &currArg, const std::strin
     return separator;
 }
 
-char getSeparator( std::size_t &ii, int argc, char **argv )
+char getSeparator( std::size_t &ii, int argc, char **argv, std::ostream &err )
 {
     std::vector< std::string > args;
     for ( auto ii = 0ULL; ii < argc; ++ii )
         args.emplace_back( argv[ ii ] );
 
-    return getSeparator( ii, args );
+    return getSeparator( ii, args, err );
 }
 
-char getSeparator( std::size_t &ii, const std::vector< std::string > &args )
+char getSeparator( std::size_t &ii, const std::vector< std::string > &args, std::ostream &err )
 {
     auto argc = args.size();
     auto currArg = args.empty() ? std::string() : args[ ii ];
     auto nextArg = ( ii >= ( argc - 1 ) ) ? std::string() : args[ ii + 1 ];
     auto nextNextArg = ( ( argc < 2 ) || ( ii >= ( argc - 2 ) ) ) ? std::string() : args[ ii + 2 ];
     auto nextNextNextArg = ( ( argc < 3 ) || ( ii >= ( argc - 3 ) ) ) ? std::string() : args[ ii + 3 ];
-    auto retVal = getSeparator( ii, currArg, nextArg, nextNextArg, nextNextNextArg, false );
+    auto retVal = getSeparator( ii, currArg, nextArg, nextNextArg, nextNextNextArg, false, err );
     return retVal;
 }
 
@@ -24,10 +24,11 @@
 
 #include <string>
 #include <vector>
+#include <iostream>
 
-char getEscapedChar( const std::string &escaped );
-char getSeparator( std::size_t &ii, int argc, char **argv );
-char getSeparator( std::size_t &ii, const std::vector< std::string > &args );
+char getEscapedChar( const std::string &escaped, std::ostream &err = std::cerr );
+char getSeparator( std::size_t &ii, int argc, char **argv, std::ostream &err = std::cerr );
+char getSeparator( std::size_t &ii, const std::vector< std::string > &args, std::ostream &err = std::cerr );
 std::vector< char * > toCStrings( const std::vector< std::string > &args );
 
     static const char *kWS = " \t\n\r\f\v";
@@ -2,10 +2,14 @@ set(project_SRCS
     main.cpp    
     Utils.cpp
     Settings.cpp
+    HyperLogLog.cpp
+    Server.cpp
 )
 
 set(project_H
     Utils.h
     Settings.h
+    HyperLogLog.h
+    Server.h
 )
 
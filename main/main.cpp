@@ -22,15 +22,15 @@
 
 #include "Utils.h"
 #include "Settings.h"
+#include "Server.h"
 
 int main( int argc, char **argv )
 {
     auto settings = CSettings( argc, argv );
-    if ( !settings.aOK() )
-        return 1;
+    if ( settings.aOK() && settings.serve() )
+        return runServer( settings.socketPath() );
+    if ( settings.aOK() && settings.connect() )
+        return runClient( settings.socketPath(), settings.forwardArgs(), settings.numFiles() == 0 );
 
-    settings.dump();
-
-    settings.process();
-    return 0;
+    return settings.run();
 }
\ No newline at end of file